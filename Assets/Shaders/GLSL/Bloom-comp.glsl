@@ -0,0 +1,113 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// Bloom pyramid, one mip per dispatch.
+//
+// default:          downsamples u_source into the next mip with the 13 tap filter from
+//                   "Next Generation Post Processing in Call of Duty: Advanced Warfare"
+// BLOOM_PREFILTER:  same, from the HDR target, and keeps only what is above the threshold.
+//                   The boxes are Karis averaged so single bright texels don't flicker.
+// BLOOM_UPSAMPLE:   blends the tent filtered lower mip (u_source) into u_destination
+//--------------------------------------------------------------------------------------
+
+layout (std140, binding = 0) uniform bloomConstants
+{
+    float u_exposure;
+    float u_threshold;
+    float u_knee;
+    float u_scatter;
+} myBloom;
+
+layout (binding = 1) uniform sampler2D u_source;
+layout (binding = 2, rgba16f) uniform image2D u_destination;
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+#include "bloom.h"
+
+float Luma(vec3 c)
+{
+    return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
+
+#ifdef BLOOM_PREFILTER
+vec3 KarisAverage(vec3 a, vec3 b, vec3 c, vec3 d, out float weight)
+{
+    vec3 box = (a + b + c + d) * 0.25;
+    weight = 1.0 / (1.0 + Luma(box));
+    return box * weight;
+}
+
+// soft knee around the threshold
+vec3 Threshold(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - myBloom.u_threshold + myBloom.u_knee, 0.0, 2.0 * myBloom.u_knee);
+    soft = soft * soft / (4.0 * myBloom.u_knee + 1e-4);
+    float contribution = max(soft, brightness - myBloom.u_threshold) / max(brightness, 1e-4);
+    return color * contribution;
+}
+#endif
+
+vec3 Tap(vec2 uv, vec2 texelSize, float x, float y)
+{
+#ifdef BLOOM_PREFILTER
+    // the HDR target can hold values half floats can't take through the filter
+    return min(texture(u_source, uv + texelSize * vec2(x, y)).rgb * myBloom.u_exposure, vec3(65000.0));
+#else
+    return texture(u_source, uv + texelSize * vec2(x, y)).rgb;
+#endif
+}
+
+void main()
+{
+    ivec2 dstSize = imageSize(u_destination);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, dstSize)))
+        return;
+
+    vec2 uv = (vec2(texel) + 0.5) / vec2(dstSize);
+    vec2 srcTexelSize = 1.0 / vec2(textureSize(u_source, 0));
+
+#ifdef BLOOM_UPSAMPLE
+    vec3 current = imageLoad(u_destination, texel).rgb;
+    vec3 lower = UpsampleTent(u_source, uv, srcTexelSize);
+    imageStore(u_destination, texel, vec4(mix(current, lower, myBloom.u_scatter), 1.0));
+#else
+    vec3 a = Tap(uv, srcTexelSize, -2.0, -2.0);
+    vec3 b = Tap(uv, srcTexelSize,  0.0, -2.0);
+    vec3 c = Tap(uv, srcTexelSize,  2.0, -2.0);
+    vec3 d = Tap(uv, srcTexelSize, -2.0,  0.0);
+    vec3 e = Tap(uv, srcTexelSize,  0.0,  0.0);
+    vec3 f = Tap(uv, srcTexelSize,  2.0,  0.0);
+    vec3 g = Tap(uv, srcTexelSize, -2.0,  2.0);
+    vec3 h = Tap(uv, srcTexelSize,  0.0,  2.0);
+    vec3 i = Tap(uv, srcTexelSize,  2.0,  2.0);
+    vec3 j = Tap(uv, srcTexelSize, -1.0, -1.0);
+    vec3 k = Tap(uv, srcTexelSize,  1.0, -1.0);
+    vec3 l = Tap(uv, srcTexelSize, -1.0,  1.0);
+    vec3 m = Tap(uv, srcTexelSize,  1.0,  1.0);
+
+#ifdef BLOOM_PREFILTER
+    float w0, w1, w2, w3, w4;
+    vec3 color = KarisAverage(j, k, l, m, w0) * 0.5
+               + KarisAverage(a, b, d, e, w1) * 0.125
+               + KarisAverage(b, c, e, f, w2) * 0.125
+               + KarisAverage(d, e, g, h, w3) * 0.125
+               + KarisAverage(e, f, h, i, w4) * 0.125;
+    color /= w0 * 0.5 + (w1 + w2 + w3 + w4) * 0.125;
+    color = Threshold(color);
+#else
+    vec3 color = e * 0.125
+               + (a + c + g + i) * 0.03125
+               + (b + d + f + h) * 0.0625
+               + (j + k + l + m) * 0.125;
+#endif
+
+    imageStore(u_destination, texel, vec4(color, 1.0));
+#endif
+}
@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// Encoding of the GBuffer targets, must match the formats of GetGBufferFormats() in GBufferVK.cpp.
+// GBUFFER_COMPACT selects the compact layout:
+//   normals            : octahedral in .xy, RG16 or RGB10A2 UNORM
+//   diffuse            : base color with a gamma of 2, RGBA8 UNORM
+//   specular roughness : perceptual roughness, metalness, AO, RGBA8 UNORM
+// the full one keeps the normal, the diffuse and the specular colors as they are, with alpha roughness.
+// The motion vectors are RG16F in both and the HDR target takes the color as it is.
+//--------------------------------------------------------------------------------------
+
+// unit vector to [0, 1]^2, the lower hemisphere folded over the diagonals
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0)
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return e * 0.5 + 0.5;
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec4 encodeGBufferNormal(vec3 normal)
+{
+#ifdef GBUFFER_COMPACT
+    return vec4(encodeOctahedral(normal), 0.0, 0.0);
+#else
+    return vec4((normal + 1.0) / 2.0, 0.0);
+#endif
+}
+
+vec3 decodeGBufferNormal(vec4 encoded)
+{
+#ifdef GBUFFER_COMPACT
+    return decodeOctahedral(encoded.xy);
+#else
+    return normalize(encoded.xyz * 2.0 - 1.0);
+#endif
+}
+
+// The compact layout keeps the metallic roughness parameters and derives the colors when decoding, the specular
+// glossiness materials go through their metalness equivalent
+void encodeGBufferMaterial(
+    vec3 baseColor, vec3 diffuseColor, vec3 specularColor, float perceptualRoughness, float ao,
+    out vec4 diffuseRT, out vec4 specularRoughnessRT)
+{
+#ifdef GBUFFER_COMPACT
+    float oneMinusSpecularStrength = 1.0 - max(max(specularColor.r, specularColor.g), specularColor.b);
+    float metallic = solveMetallic(diffuseColor, specularColor, oneMinusSpecularStrength);
+    diffuseRT = vec4(sqrt(clamp(baseColor, 0.0, 1.0)), 0.0);
+    specularRoughnessRT = vec4(perceptualRoughness, metallic, ao, 0.0);
+#else
+    diffuseRT = vec4(diffuseColor, 0.0);
+    specularRoughnessRT = vec4(specularColor, perceptualRoughness * perceptualRoughness);
+#endif
+}
+
+void decodeGBufferMaterial(
+    vec4 diffuseRT, vec4 specularRoughnessRT,
+    out vec3 diffuseColor, out vec3 specularColor, out float perceptualRoughness, out float ao)
+{
+#ifdef GBUFFER_COMPACT
+    const vec3 f0 = vec3(0.04, 0.04, 0.04);
+    vec3 baseColor = diffuseRT.rgb * diffuseRT.rgb;
+    float metallic = specularRoughnessRT.g;
+    diffuseColor = baseColor * (vec3(1.0, 1.0, 1.0) - f0) * (1.0 - metallic);
+    specularColor = mix(f0, baseColor, metallic);
+    perceptualRoughness = specularRoughnessRT.r;
+    ao = specularRoughnessRT.b;
+#else
+    diffuseColor = diffuseRT.rgb;
+    specularColor = specularRoughnessRT.rgb;
+    perceptualRoughness = sqrt(specularRoughnessRT.a);
+    ao = 1.0;
+#endif
+}
@@ -0,0 +1,67 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// Debug views of the GBuffer, see GBufferView.h. Decodes the normal, diffuse and
+// specular roughness targets with the helpers of GBufferEncoding.glsl, in the layout
+// they were written with (GBUFFER_COMPACT), and writes one of them over the render
+// area of the HDR target.
+//--------------------------------------------------------------------------------------
+
+// must match GBufferViewMode in GBufferView.h
+#define GBUFFER_VIEW_NORMALS    1
+#define GBUFFER_VIEW_DIFFUSE    2
+#define GBUFFER_VIEW_SPECULAR   3
+#define GBUFFER_VIEW_ROUGHNESS  4
+#define GBUFFER_VIEW_AO         5
+
+#include "functions.glsl"
+#include "GBufferEncoding.glsl"
+
+layout (binding = 0) uniform sampler2D u_normals;
+layout (binding = 1) uniform sampler2D u_diffuse;
+layout (binding = 2) uniform sampler2D u_specularRoughness;
+#ifdef HDR_R11G11B10
+layout (binding = 3, r11f_g11f_b10f) uniform writeonly image2D u_hdr;
+#else
+layout (binding = 3, rgba16f) uniform writeonly image2D u_hdr;
+#endif
+
+layout (std140, binding = 4) uniform GBufferViewConstants
+{
+    ivec2 u_renderSize;
+    int u_mode;
+    int u_padding;
+};
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, u_renderSize)))
+        return;
+
+    vec3 diffuseColor, specularColor;
+    float perceptualRoughness, ao;
+    decodeGBufferMaterial(
+        texelFetch(u_diffuse, texel, 0), texelFetch(u_specularRoughness, texel, 0),
+        diffuseColor, specularColor, perceptualRoughness, ao);
+
+    vec3 color = vec3(0.0);
+    if (u_mode == GBUFFER_VIEW_NORMALS)
+        color = decodeGBufferNormal(texelFetch(u_normals, texel, 0)) * 0.5 + 0.5;
+    else if (u_mode == GBUFFER_VIEW_DIFFUSE)
+        color = diffuseColor;
+    else if (u_mode == GBUFFER_VIEW_SPECULAR)
+        color = specularColor;
+    else if (u_mode == GBUFFER_VIEW_ROUGHNESS)
+        color = vec3(perceptualRoughness);
+    else if (u_mode == GBUFFER_VIEW_AO)
+        color = vec3(ao);
+
+    imageStore(u_hdr, texel, vec4(color, 1.0));
+}
@@ -34,6 +34,19 @@ layout (std140, binding = ID_PER_FRAME) uniform myFrame
     mat4 u_MVPMatrix;
 } myPerFrame;
 
+#ifdef ID_NODE_MATRICES
+// GPU driven drawing, the culling shader puts the node index in firstInstance. The instanced draws use the same
+// pipelines with their instance matrices in place of the node matrices
+layout (std430, binding = ID_NODE_MATRICES) readonly buffer nodeMatrices
+{
+    mat4 u_NodeMatrices[];  // current, previous
+} myNodeMatrices;
+
+mat4 GetWorldMatrix()
+{
+    return myNodeMatrices.u_NodeMatrices[gl_InstanceIndex * 2];
+}
+#else
 layout (std140, binding = ID_PER_OBJECT) uniform perObject
 {
     mat4 u_ModelMatrix;
@@ -43,6 +56,7 @@ mat4 GetWorldMatrix()
 {
     return myPerObject.u_ModelMatrix;
 }
+#endif
 
 mat4 GetCameraViewProj()
 {
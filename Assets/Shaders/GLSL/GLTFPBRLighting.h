@@ -60,15 +60,65 @@ float GetSSAO(vec2 coords)
 }
 #endif
 
+//
+//  Clustered lights, binned by LightClusters-comp.glsl
+//
+#if defined(ID_LIGHTS) && defined(ID_LIGHT_CLUSTERS)
+layout (scalar, set = 0, binding = ID_LIGHTS) readonly buffer lights
+{
+    Light u_lights[];
+};
+
+layout (std430, set = 0, binding = ID_LIGHT_CLUSTERS) readonly buffer lightClusters
+{
+    uint u_lightClusters[];
+};
+
+// Index of the light count of the cluster holding the pixel, its light indices follow it
+uint getLightClusterBase(vec3 worldPos)
+{
+    vec2 uv = gl_FragCoord.xy * myPerFrame.u_invScreenResolution;
+    uvec2 tile = uvec2(clamp(uv * vec2(LIGHT_CLUSTER_COUNT_X, LIGHT_CLUSTER_COUNT_Y), vec2(0.0), vec2(LIGHT_CLUSTER_COUNT_X - 1, LIGHT_CLUSTER_COUNT_Y - 1)));
+
+    float depth = -(myPerFrame.u_mCameraView * vec4(worldPos, 1.0)).z;
+    float slice = floor(log(max(depth, 1e-4)) * myPerFrame.u_clusterDepthScale + myPerFrame.u_clusterDepthBias);
+    uint z = uint(clamp(slice, 0.0, float(LIGHT_CLUSTER_COUNT_Z - 1)));
+
+    return ((z * LIGHT_CLUSTER_COUNT_Y + tile.y) * LIGHT_CLUSTER_COUNT_X + tile.x) * LIGHT_CLUSTER_STRIDE;
+}
+#endif
+
 // Calculation of the lighting contribution from an optional Image Based Light source.
 // Precomputed Environment Maps are required uniform inputs and are computed as outlined in [1].
 // See our README.md on Environment Maps [3] for additional discussion.
 #ifdef USE_IBL
+#ifdef USE_IBL_SH
+// Diffuse irradiance from its spherical harmonics, must match EvaluateIrradianceSH() in SphericalHarmonics.cpp
+vec3 evaluateIrradianceSH(vec3 n)
+{
+    vec3 irradiance = myPerFrame.u_irradianceSH[0].rgb;
+    irradiance += myPerFrame.u_irradianceSH[1].rgb * n.y;
+    irradiance += myPerFrame.u_irradianceSH[2].rgb * n.z;
+    irradiance += myPerFrame.u_irradianceSH[3].rgb * n.x;
+    irradiance += myPerFrame.u_irradianceSH[4].rgb * (n.x * n.y);
+    irradiance += myPerFrame.u_irradianceSH[5].rgb * (n.y * n.z);
+    irradiance += myPerFrame.u_irradianceSH[6].rgb * (3.0 * n.z * n.z - 1.0);
+    irradiance += myPerFrame.u_irradianceSH[7].rgb * (n.x * n.z);
+    irradiance += myPerFrame.u_irradianceSH[8].rgb * (n.x * n.x - n.y * n.y);
+    return max(irradiance, vec3(0.0));
+}
+#endif
+
+// IBL_SPECULAR_LOD_MAX, the last mip of the specular cube, comes from the PBR pass
+#ifndef IBL_SPECULAR_LOD_MAX
+#define IBL_SPECULAR_LOD_MAX 9.0 // resolution of 512x512 of the IBL
+#endif
+
 vec3 getIBLContribution(MaterialInfo materialInfo, vec3 n, vec3 v)
 {
     float NdotV = clamp(dot(n, v), 0.0, 1.0);
     
-    float u_MipCount = 9.0; // resolution of 512x512 of the IBL
+    float u_MipCount = float(IBL_SPECULAR_LOD_MAX);
     float lod = clamp(materialInfo.perceptualRoughness * float(u_MipCount), 0.0, float(u_MipCount));
     vec3 reflection = normalize(reflect(-v, n));
 
@@ -76,7 +126,11 @@ vec3 getIBLContribution(MaterialInfo materialInfo, vec3 n, vec3 v)
     // retrieve a scale and bias to F0. See [1], Figure 3
     vec2 brdf = texture(u_brdfLUT, brdfSamplePoint).rg;
 
+#ifdef USE_IBL_SH
+    vec3 diffuseLight = evaluateIrradianceSH(n);
+#else
     vec3 diffuseLight = texture(u_DiffuseEnvSampler, n).rgb;
+#endif
 
 #ifdef USE_TEX_LOD
     vec3 specularLight = textureLod(u_SpecularEnvSampler, reflection, lod).rgb;
@@ -252,10 +306,13 @@ vec3 doPbrLighting(VS2PS Input, PerFrame perFrame, vec3 diffuseColor, vec3 specu
     }
 #endif
 
-#ifdef USE_PUNCTUAL
-    for (int i = 0; i < myPerFrame.u_lightCount; ++i)
+#if defined(USE_PUNCTUAL) && defined(ID_LIGHTS) && defined(ID_LIGHT_CLUSTERS)
+    // only the lights that reach the pixel's cluster
+    uint clusterBase = getLightClusterBase(worldPos);
+    uint clusterLightCount = u_lightClusters[clusterBase];
+    for (uint i = 0; i < clusterLightCount; ++i)
     {
-        Light light = myPerFrame.u_lights[i];
+        Light light = u_lights[u_lightClusters[clusterBase + 1 + i]];
 
         float shadowFactor = DoSpotShadow(worldPos, light);
 
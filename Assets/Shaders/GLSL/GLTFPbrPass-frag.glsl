@@ -50,6 +50,11 @@ precision highp float;
 #include "GLTF_VS2PS_IO.glsl"
 layout (location = 0) in VS2PS Input;
 
+#ifdef DEF_depthPrePass
+// the depth pre-pass did the alpha test, only the fragments that won the depth test run
+layout (early_fragment_tests) in;
+#endif
+
 //--------------------------------------------------------------------------------------
 // PS Outputs
 //--------------------------------------------------------------------------------------
@@ -113,10 +118,14 @@ layout (scalar, set=0, binding = 1) uniform perObject
 #include "functions.glsl"
 #include "shadowFiltering.h"
 #include "GLTFPBRLighting.h"
+#include "GBufferEncoding.glsl"
 
 void main()
 {
+#ifndef DEF_depthPrePass
     discardPixelIfAlphaCutOff(Input);
+#endif
+    discardPixelIfLODFading(u_pbrParams.u_LODFade);
 
     float alpha;
     float perceptualRoughness;
@@ -124,25 +133,26 @@ void main()
     vec3 specularColor;
 	getPBRParams(Input, u_pbrParams, diffuseColor, specularColor, perceptualRoughness, alpha);
 
-    // Roughness is authored as perceptual roughness; as is convention,
-    // convert to material roughness by squaring the perceptual roughness [2].
-    float alphaRoughness = perceptualRoughness * perceptualRoughness;
-
 #ifdef HAS_MOTION_VECTORS_RT
     Output_motionVect = Input.CurrPosition.xy / Input.CurrPosition.w -
                         Input.PrevPosition.xy / Input.PrevPosition.w;
 #endif
 
+#if defined(HAS_SPECULAR_ROUGHNESS_RT) || defined(HAS_DIFFUSE_RT)
+    vec4 diffuseRT, specularRoughnessRT;
+    encodeGBufferMaterial(getBaseColor(Input, u_pbrParams).rgb, diffuseColor, specularColor, perceptualRoughness, getOcclusion(Input), diffuseRT, specularRoughnessRT);
+#endif
+
 #ifdef HAS_SPECULAR_ROUGHNESS_RT
-    Output_specularRoughness = vec4(specularColor, alphaRoughness);
+    Output_specularRoughness = specularRoughnessRT;
 #endif
 
 #ifdef HAS_DIFFUSE_RT
-    Output_diffuseColor = vec4(diffuseColor, 0);
+    Output_diffuseColor = diffuseRT;
 #endif
 
 #ifdef HAS_NORMALS_RT
-    Output_normal = vec4((getPixelNormal(Input) + 1) / 2, 0);
+    Output_normal = encodeGBufferNormal(getPixelNormal(Input));
 #endif
 
 #ifdef HAS_FORWARD_RT
@@ -35,6 +35,24 @@ layout (std140, binding = ID_PER_FRAME) uniform _PerFrame
     PerFrame myPerFrame;
 };
 
+#ifdef ID_NODE_MATRICES
+// GPU driven drawing, the culling shader puts the node index in firstInstance. The instanced draws use the same
+// pipelines with their instance matrices in place of the node matrices
+layout (std430, binding = ID_NODE_MATRICES) readonly buffer nodeMatrices
+{
+    mat4 u_NodeMatrices[];  // current, previous
+} myNodeMatrices;
+
+mat4 GetWorldMatrix()
+{
+    return myNodeMatrices.u_NodeMatrices[gl_InstanceIndex * 2];
+}
+
+mat4 GetPrevWorldMatrix()
+{
+    return myNodeMatrices.u_NodeMatrices[gl_InstanceIndex * 2 + 1];
+}
+#else
 layout (std140, binding = ID_PER_OBJECT) uniform perObject
 {
     mat4 u_mCurrWorld;
@@ -46,14 +64,15 @@ mat4 GetWorldMatrix()
     return myPerObject.u_mCurrWorld;
 }
 
-mat4 GetCameraViewProj()
+mat4 GetPrevWorldMatrix()
 {
-    return myPerFrame.u_mCameraCurrViewProj;
+    return myPerObject.u_mPrevWorld;
 }
+#endif
 
-mat4 GetPrevWorldMatrix()
+mat4 GetCameraViewProj()
 {
-    return myPerObject.u_mPrevWorld;
+    return myPerFrame.u_mCameraCurrViewProj;
 }
 
 mat4 GetPrevCameraViewProj()
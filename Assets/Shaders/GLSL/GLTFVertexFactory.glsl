@@ -47,6 +47,9 @@
 
 layout (location = 0) out VS2PS Output;
 
+// the depth pass and the color passes have to come up with the same depth for the depth pre-pass' EQUAL test
+invariant gl_Position;
+
 void gltfVertexFactory()
 {
 #ifdef ID_WEIGHTS_0
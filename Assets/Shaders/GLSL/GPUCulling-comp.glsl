@@ -0,0 +1,242 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// GPU driven culling, one thread per instance and view (gl_WorkGroupID.y is the view).
+// Visible instances get a VkDrawIndexedIndirectCommand appended to the group of their primitive, with the indices of
+// the level of detail picked for them.
+// Structures must match GLTFGPUCullingVK.h
+//--------------------------------------------------------------------------------------
+
+#define INVALID_GROUP 0xFFFFFFFFu
+
+// CullView.flags
+#define VIEW_OCCLUSION          1u
+#define VIEW_CASTERS_STATIC     2u
+#define VIEW_CASTERS_DYNAMIC    4u
+
+// Instance.flags
+#define INSTANCE_DYNAMIC        1u
+
+struct CullView
+{
+    mat4 viewProj;
+    uint pass;
+    uint commandBase;
+    uint countBase;
+    uint flags;
+    float lodThreshold;     // pixels, 0 draws the full meshes
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout (std140, binding = 0) uniform cullFrame
+{
+    CullView u_views[MAX_VIEWS];
+    mat4 u_hizViewProj;
+    vec2 u_hizSize;
+    uint u_hizMipCount;
+    uint u_instanceCount;
+    uint u_primitiveCount;
+    vec4 u_lodCameraPos;
+    float u_lodPixelsPerUnit;
+};
+
+struct Instance
+{
+    uint nodeIndex;
+    uint primitiveIndex;
+    uint flags;
+    uint pad;
+    vec4 center;
+    vec4 extents;
+};
+
+layout (std430, binding = 1) readonly buffer instances
+{
+    Instance u_instances[];
+};
+
+// the levels of detail, LOD 0 (the full mesh) first, lodErrors[0] is 0
+struct DrawRecord
+{
+    uint  group;
+    uint  commandBase;
+    int   vertexOffset;
+    uint  lodCount;
+    uint  indexCounts[MAX_LODS];
+    uint  firstIndices[MAX_LODS];
+    float lodErrors[MAX_LODS];
+};
+
+layout (std430, binding = 2) readonly buffer drawRecords
+{
+    DrawRecord u_drawRecords[];
+};
+
+layout (std430, binding = 3) readonly buffer nodeMatrices
+{
+    mat4 u_nodeMatrices[];  // current, previous
+};
+
+struct DrawIndexedIndirectCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+layout (std430, binding = 4) writeonly buffer commands
+{
+    DrawIndexedIndirectCommand u_commands[];
+};
+
+layout (std430, binding = 5) buffer counts
+{
+    uint u_counts[];
+};
+
+layout (binding = 6) uniform sampler2D u_hiz;
+
+layout (local_size_x = 64) in;
+
+// Same test as CameraFrustumToBoxCollision(), the box is culled when all its corners are outside the same plane
+bool IsOutsideFrustum(mat4 viewProj, vec3 center, vec3 extents)
+{
+    vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+    vec4 planes[5];
+    planes[0] = rows[3] + rows[0];  // left
+    planes[1] = rows[3] - rows[0];  // right
+    planes[2] = rows[3] + rows[1];  // bottom
+    planes[3] = rows[3] - rows[1];  // top
+    planes[4] = rows[2];            // near
+
+    for (int i = 0; i < 5; i++)
+    {
+        float d = dot(planes[i].xyz, center) + planes[i].w;
+        float r = dot(abs(planes[i].xyz), extents);
+        if (d + r < 0.0)
+            return true;
+    }
+    return false;
+}
+
+bool IsOccluded(vec3 center, vec3 extents)
+{
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float minZ = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = center + extents * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = u_hizViewProj * vec4(corner, 1.0);
+
+        // crosses the camera plane, can't tell
+        if (clip.w <= 1e-5)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        // the viewport is flipped, uv.y goes down
+        vec2 uv = vec2(0.5 + 0.5 * ndc.x, 0.5 - 0.5 * ndc.y);
+        uvMin = min(uvMin, uv);
+        uvMax = max(uvMax, uv);
+        minZ = min(minZ, ndc.z);
+    }
+
+    uvMin = clamp(uvMin, vec2(0.0), vec2(1.0));
+    uvMax = clamp(uvMax, vec2(0.0), vec2(1.0));
+
+    // pick the mip where the rectangle covers at most 2x2 texels
+    vec2 size = (uvMax - uvMin) * u_hizSize;
+    int mip = int(ceil(log2(max(max(size.x, size.y), 1.0))));
+    mip = clamp(mip, 0, int(u_hizMipCount) - 1);
+
+    ivec2 mipSize = textureSize(u_hiz, mip);
+    ivec2 texelMin = clamp(ivec2(uvMin * vec2(mipSize)), ivec2(0), mipSize - 1);
+    ivec2 texelMax = clamp(ivec2(uvMax * vec2(mipSize)), ivec2(0), mipSize - 1);
+    if (any(greaterThan(texelMax - texelMin, ivec2(1))) && mip + 1 < int(u_hizMipCount))
+    {
+        mip++;
+        mipSize = textureSize(u_hiz, mip);
+        texelMin = clamp(ivec2(uvMin * vec2(mipSize)), ivec2(0), mipSize - 1);
+        texelMax = clamp(ivec2(uvMax * vec2(mipSize)), ivec2(0), mipSize - 1);
+    }
+
+    float maxZ = texelFetch(u_hiz, texelMin, mip).r;
+    maxZ = max(maxZ, texelFetch(u_hiz, ivec2(texelMax.x, texelMin.y), mip).r);
+    maxZ = max(maxZ, texelFetch(u_hiz, ivec2(texelMin.x, texelMax.y), mip).r);
+    maxZ = max(maxZ, texelFetch(u_hiz, texelMax, mip).r);
+
+    return minZ > maxZ;
+}
+
+// Same as SelectMeshLOD() with no hysteresis and no crossfade: the coarsest level whose error projected on the screen
+// stays within the threshold. center is in world space, extents in object space
+uint SelectLOD(uint recordIndex, mat4 world, vec3 center, vec3 extents, float threshold)
+{
+    uint lodCount = u_drawRecords[recordIndex].lodCount;
+    if (lodCount <= 1 || threshold <= 0.0)
+        return 0;
+
+    float scale = max(max(length(world[0].xyz), length(world[1].xyz)), length(world[2].xyz));
+    float distance = length(center - u_lodCameraPos.xyz) - scale * length(extents);
+    if (distance <= 0.0)
+        return 0;
+
+    float toPixels = scale * u_lodPixelsPerUnit / distance;
+    uint lod = 0;
+    while (lod + 1 < lodCount && u_drawRecords[recordIndex].lodErrors[lod + 1] * toPixels <= threshold)
+        lod++;
+    return lod;
+}
+
+void main()
+{
+    uint instanceIndex = gl_GlobalInvocationID.x;
+    if (instanceIndex >= u_instanceCount)
+        return;
+
+    CullView view = u_views[gl_WorkGroupID.y];
+    Instance instance = u_instances[instanceIndex];
+
+    uint casterBit = (instance.flags & INSTANCE_DYNAMIC) != 0 ? VIEW_CASTERS_DYNAMIC : VIEW_CASTERS_STATIC;
+    if ((view.flags & casterBit) == 0)
+        return;
+
+    uint recordIndex = view.pass * u_primitiveCount + instance.primitiveIndex;
+    uint group = u_drawRecords[recordIndex].group;
+    if (group == INVALID_GROUP)
+        return;
+
+    // world space bounds
+    mat4 world = u_nodeMatrices[instance.nodeIndex * 2];
+    vec3 center = (world * vec4(instance.center.xyz, 1.0)).xyz;
+    mat3 absWorld = mat3(abs(world[0].xyz), abs(world[1].xyz), abs(world[2].xyz));
+    vec3 extents = absWorld * instance.extents.xyz;
+
+    if (IsOutsideFrustum(view.viewProj, center, extents))
+        return;
+
+    if ((view.flags & VIEW_OCCLUSION) != 0 && IsOccluded(center, extents))
+        return;
+
+    uint lod = SelectLOD(recordIndex, world, center, instance.extents.xyz, view.lodThreshold);
+    uint slot = atomicAdd(u_counts[view.countBase + group], 1);
+
+    DrawIndexedIndirectCommand command;
+    command.indexCount = u_drawRecords[recordIndex].indexCounts[lod];
+    command.instanceCount = 1;
+    command.firstIndex = u_drawRecords[recordIndex].firstIndices[lod];
+    command.vertexOffset = u_drawRecords[recordIndex].vertexOffset;
+    command.firstInstance = instance.nodeIndex;
+    u_commands[view.commandBase + u_drawRecords[recordIndex].commandBase + slot] = command;
+}
@@ -0,0 +1,37 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// Builds one level of the Hi-Z pyramid used by GPUCulling-comp.glsl.
+// Each texel keeps the farthest depth of the source texels it covers, when the source
+// size is odd that is up to 3x3 texels so the pyramid stays conservative.
+//--------------------------------------------------------------------------------------
+
+layout (binding = 0) uniform sampler2D u_source;
+layout (binding = 1, r32f) uniform writeonly image2D u_destination;
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+void main()
+{
+    ivec2 dstSize = imageSize(u_destination);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, dstSize)))
+        return;
+
+    ivec2 srcSize = textureSize(u_source, 0);
+    ivec2 srcMin = (texel * srcSize) / dstSize;
+    ivec2 srcMax = min(((texel + 1) * srcSize + dstSize - 1) / dstSize, srcSize);
+
+    float maxZ = 0.0;
+    for (int y = srcMin.y; y < srcMax.y; y++)
+    {
+        for (int x = srcMin.x; x < srcMax.x; x++)
+            maxZ = max(maxZ, texelFetch(u_source, ivec2(x, y), 0).r);
+    }
+
+    imageStore(u_destination, texel, vec4(maxZ));
+}
@@ -0,0 +1,94 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// Projection of an environment cube map on the 9 spherical harmonics of its diffuse irradiance, the compute side of
+// ProjectCubeMapOnIrradianceSH() in SphericalHarmonics.cpp for the maps the CPU can't read.
+//
+// default:          a group per 8x8 texels of a face u_faceSize wide, read from the mip of u_environment that has
+//                   about that size. Each group writes its sums, weighted by the solid angle of the texels, to
+//                   u_partials, the total weight in the w of the first one.
+// IBL_SH_RESOLVE:   a single group adds up the u_partialCount partial sums and writes the scaled coefficients to u_sh
+//--------------------------------------------------------------------------------------
+
+#include "iblSampling.h"
+
+#define SH_COUNT 9
+
+layout (binding = 1) uniform samplerCube u_environment;
+layout (std430, binding = 2) buffer partialSums { vec4 u_partials[]; };
+layout (std430, binding = 3) buffer coefficients { vec4 u_sh[SH_COUNT]; };
+
+#ifdef IBL_SH_RESOLVE
+layout (local_size_x = 64) in;
+
+// must match IrradianceSHScale in SphericalHarmonics.cpp
+const float shScale[SH_COUNT] = float[SH_COUNT](
+    1.0 / (4.0 * IBL_PI),
+    1.0 / (2.0 * IBL_PI), 1.0 / (2.0 * IBL_PI), 1.0 / (2.0 * IBL_PI),
+    15.0 / (16.0 * IBL_PI), 15.0 / (16.0 * IBL_PI), 5.0 / (64.0 * IBL_PI), 15.0 / (16.0 * IBL_PI), 15.0 / (64.0 * IBL_PI));
+#else
+layout (local_size_x = 8, local_size_y = 8) in;
+#endif
+
+shared vec4 s_sums[64][SH_COUNT];
+
+void main()
+{
+    uint lane = gl_LocalInvocationIndex;
+    vec4 sums[SH_COUNT];
+
+#ifdef IBL_SH_RESOLVE
+    for (uint c = 0; c < SH_COUNT; c++)
+        sums[c] = vec4(0.0);
+    for (uint i = lane; i < myIBL.u_partialCount; i += 64)
+    {
+        for (uint c = 0; c < SH_COUNT; c++)
+            sums[c] += u_partials[i * SH_COUNT + c];
+    }
+#else
+    uvec3 id = gl_GlobalInvocationID;
+    vec3 direction = cubeMapDirection(id.z, cubeMapFaceCoords(id.xy, myIBL.u_faceSize));
+
+    // 1 + s^2 + t^2, the solid angle of a texel goes with its inverse to the power 3/2
+    float invLength = inversesqrt(dot(direction, direction));
+    float weight = invLength * invLength * invLength;
+    vec3 n = direction * invLength;
+
+    vec4 radiance = vec4(textureLod(u_environment, n, myIBL.u_sourceLod).rgb, 1.0) * weight;
+
+    float polynomials[SH_COUNT] = float[SH_COUNT](
+        1.0, n.y, n.z, n.x, n.x * n.y, n.y * n.z, 3.0 * n.z * n.z - 1.0, n.x * n.z, n.x * n.x - n.y * n.y);
+    for (uint c = 0; c < SH_COUNT; c++)
+        sums[c] = radiance * polynomials[c];
+#endif
+
+    for (uint c = 0; c < SH_COUNT; c++)
+        s_sums[lane][c] = sums[c];
+    barrier();
+
+    for (uint stride = 32; stride > 0; stride >>= 1)
+    {
+        if (lane < stride)
+        {
+            for (uint c = 0; c < SH_COUNT; c++)
+                s_sums[lane][c] += s_sums[lane + stride][c];
+        }
+        barrier();
+    }
+
+    if (lane < SH_COUNT)
+    {
+#ifdef IBL_SH_RESOLVE
+        // the weights sum up to the whole sphere
+        float normalization = 4.0 * IBL_PI / s_sums[0][0].w;
+        u_sh[lane] = vec4(s_sums[0][lane].rgb * normalization * shScale[lane], 0.0);
+#else
+        uint group = (gl_WorkGroupID.z * gl_NumWorkGroups.y + gl_WorkGroupID.y) * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+        u_partials[group * SH_COUNT + lane] = s_sums[0][lane];
+#endif
+    }
+}
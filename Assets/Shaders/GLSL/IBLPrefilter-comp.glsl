@@ -0,0 +1,73 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// GGX prefiltering of an environment cube map into one mip of the specular cube, a dispatch per mip.
+//
+// The lobe is importance sampled as in "Real Shading in Unreal Engine 4" (Karis), with the view and the reflection
+// along the normal of the split sum approximation. Each sample reads the mip of u_environment whose texels cover its
+// share of the lobe ("GPU-Based Importance Sampling", Colbert and Krivanek), which keeps a few dozen samples free of
+// noise. A roughness of 0 is a plain copy from the mip that has about the size of the destination.
+//--------------------------------------------------------------------------------------
+
+#include "iblSampling.h"
+
+layout (binding = 1) uniform samplerCube u_environment;
+layout (binding = 2, rgba16f) uniform writeonly image2DArray u_destination;
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+void main()
+{
+    uvec3 id = gl_GlobalInvocationID;
+    if (id.x >= myIBL.u_faceSize || id.y >= myIBL.u_faceSize)
+        return;
+
+    vec3 n = normalize(cubeMapDirection(id.z, cubeMapFaceCoords(id.xy, myIBL.u_faceSize)));
+
+    vec3 color;
+    if (myIBL.u_roughness == 0.0)
+    {
+        color = textureLod(u_environment, n, max(log2(myIBL.u_sourceSize / float(myIBL.u_faceSize)), 0.0)).rgb;
+    }
+    else
+    {
+        float alpha = myIBL.u_roughness * myIBL.u_roughness;
+        float alphaSq = alpha * alpha;
+        float texelSolidAngle = 4.0 * IBL_PI / (6.0 * myIBL.u_sourceSize * myIBL.u_sourceSize);
+
+        vec3 up = abs(n.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+        vec3 tangentX = normalize(cross(up, n));
+        vec3 tangentY = cross(n, tangentX);
+
+        vec4 sum = vec4(0.0);
+        for (uint i = 0; i < myIBL.u_sampleCount; i++)
+        {
+            // GGX distributed half vector
+            vec2 xi = hammersley(i, myIBL.u_sampleCount);
+            float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alphaSq - 1.0) * xi.y));
+            float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+            float phi = 2.0 * IBL_PI * xi.x;
+            vec3 h = tangentX * (sinTheta * cos(phi)) + tangentY * (sinTheta * sin(phi)) + n * cosTheta;
+
+            vec3 l = 2.0 * dot(n, h) * h - n;
+            float NdotL = dot(n, l);
+            if (NdotL <= 0.0)
+                continue;
+
+            // with v = n the pdf of l is D(h) / 4
+            float d = cosTheta * cosTheta * (alphaSq - 1.0) + 1.0;
+            float pdf = alphaSq / (IBL_PI * d * d) * 0.25;
+            float sampleSolidAngle = 1.0 / (float(myIBL.u_sampleCount) * pdf + 1e-4);
+            float lod = max(0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0, 0.0);
+
+            sum += vec4(textureLod(u_environment, l, lod).rgb * NdotL, NdotL);
+        }
+        color = sum.rgb / max(sum.w, 1e-4);
+    }
+
+    imageStore(u_destination, ivec3(id), vec4(color, 1.0));
+}
@@ -0,0 +1,160 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+// this makes the structures declared with a scalar layout match the c structures
+#extension GL_EXT_scalar_block_layout : enable
+
+//--------------------------------------------------------------------------------------
+// Clustered light assignment, one thread per cluster.
+// The lights are loaded in batches into shared memory, every thread tests its cluster's view space box against
+// the bounding sphere of each light of the batch. BuildLightClusters() in GLTFLightClusters.cpp is the CPU reference,
+// the math has to stay the same. The clusters touching more lights than their list holds keep the first ones and
+// count the rest in u_overflow.
+//--------------------------------------------------------------------------------------
+
+#include "perFrameStruct.h"
+
+#define GROUP_SIZE 64
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y * LIGHT_CLUSTER_COUNT_Z)
+
+layout (scalar, binding = 0) uniform perFrame
+{
+    PerFrame myPerFrame;
+};
+
+layout (scalar, binding = 1) readonly buffer lights
+{
+    Light u_lights[];
+};
+
+layout (std430, binding = 2) writeonly buffer lightClusters
+{
+    uint u_lightClusters[];
+};
+
+layout (std430, binding = 3) buffer overflow
+{
+    uint u_overflowClusters;
+    uint u_overflowLights;
+};
+
+layout (local_size_x = GROUP_SIZE) in;
+
+// view space center and radius, a negative radius reaches everything
+shared vec4 s_lightBounds[GROUP_SIZE];
+shared bool s_lightValid[GROUP_SIZE];
+
+void getClusterBounds(uvec3 cluster, out vec3 boxMin, out vec3 boxMax)
+{
+    float depthNear = exp((float(cluster.z) - myPerFrame.u_clusterDepthBias) / myPerFrame.u_clusterDepthScale);
+    float depthFar = exp((float(cluster.z + 1) - myPerFrame.u_clusterDepthBias) / myPerFrame.u_clusterDepthScale);
+
+    // tiles go down the screen, NDC y goes up
+    vec2 ndcMin = vec2(-1.0 + 2.0 * float(cluster.x) / LIGHT_CLUSTER_COUNT_X, 1.0 - 2.0 * float(cluster.y + 1) / LIGHT_CLUSTER_COUNT_Y);
+    vec2 ndcMax = vec2(-1.0 + 2.0 * float(cluster.x + 1) / LIGHT_CLUSTER_COUNT_X, 1.0 - 2.0 * float(cluster.y) / LIGHT_CLUSTER_COUNT_Y);
+
+    // the frustum widens with the depth, the extremes are either on the near or on the far side of the slice
+    boxMin.xy = min(ndcMin * depthNear, ndcMin * depthFar) * myPerFrame.u_clusterProjScale;
+    boxMax.xy = max(ndcMax * depthNear, ndcMax * depthFar) * myPerFrame.u_clusterProjScale;
+
+    // the camera looks down -z
+    boxMin.z = -depthFar;
+    boxMax.z = -depthNear;
+}
+
+bool getLightBounds(Light light, out vec4 bounds)
+{
+    bounds = vec4(0.0, 0.0, 0.0, -1.0);
+    if (light.type == LightType_Directional || light.range < 0.0)
+        return true;
+    if (light.range == 0.0)
+        return false;
+
+    vec3 center = light.position;
+    float radius = light.range;
+
+    // smallest sphere around the cone, spots shine along -direction
+    if (light.type == LightType_Spot && light.outerConeCos > 0.0)
+    {
+        vec3 axis = -light.direction;
+        if (light.outerConeCos < 0.70710678)
+        {
+            center += axis * (light.range * light.outerConeCos);
+            radius = light.range * sqrt(1.0 - light.outerConeCos * light.outerConeCos);
+        }
+        else
+        {
+            radius = light.range / (2.0 * light.outerConeCos);
+            center += axis * radius;
+        }
+    }
+
+    bounds = vec4((myPerFrame.u_mCameraView * vec4(center, 1.0)).xyz, radius);
+    return true;
+}
+
+bool sphereIntersectsBox(vec4 sphere, vec3 boxMin, vec3 boxMax)
+{
+    if (sphere.w < 0.0)
+        return true;
+
+    vec3 d = max(max(boxMin - sphere.xyz, vec3(0.0)), sphere.xyz - boxMax);
+    return dot(d, d) <= sphere.w * sphere.w;
+}
+
+void main()
+{
+    uint cluster = gl_GlobalInvocationID.x;
+    bool bActive = cluster < LIGHT_CLUSTER_COUNT;
+
+    uvec3 clusterId = uvec3(
+        cluster % LIGHT_CLUSTER_COUNT_X,
+        (cluster / LIGHT_CLUSTER_COUNT_X) % LIGHT_CLUSTER_COUNT_Y,
+        cluster / (LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y));
+
+    vec3 boxMin, boxMax;
+    getClusterBounds(clusterId, boxMin, boxMax);
+
+    uint base = cluster * LIGHT_CLUSTER_STRIDE;
+    uint count = 0;
+
+    // all the threads take part in the loads, even the ones past the last cluster
+    uint lightCount = uint(myPerFrame.u_lightCount);
+    for (uint first = 0; first < lightCount; first += GROUP_SIZE)
+    {
+        uint lightIndex = first + gl_LocalInvocationIndex;
+        vec4 bounds = vec4(0.0);
+        bool bValid = lightIndex < lightCount && getLightBounds(u_lights[lightIndex], bounds);
+        s_lightBounds[gl_LocalInvocationIndex] = bounds;
+        s_lightValid[gl_LocalInvocationIndex] = bValid;
+        barrier();
+
+        if (bActive)
+        {
+            uint batchCount = min(uint(GROUP_SIZE), lightCount - first);
+            for (uint i = 0; i < batchCount; i++)
+            {
+                if (s_lightValid[i] && sphereIntersectsBox(s_lightBounds[i], boxMin, boxMax))
+                {
+                    if (count < LIGHT_CLUSTER_STRIDE - 1)
+                        u_lightClusters[base + 1 + count] = first + i;
+                    count++;
+                }
+            }
+        }
+        barrier();
+    }
+
+    if (bActive)
+    {
+        uint stored = min(count, uint(LIGHT_CLUSTER_STRIDE - 1));
+        u_lightClusters[base] = stored;
+        if (count > stored)
+        {
+            atomicAdd(u_overflowClusters, 1);
+            atomicAdd(u_overflowLights, count - stored);
+        }
+    }
+}
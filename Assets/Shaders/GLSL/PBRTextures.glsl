@@ -70,7 +70,9 @@
 #endif
 
 #ifdef USE_IBL
+#ifndef USE_IBL_SH
 layout (set=1, binding = ID_diffuseCube) uniform samplerCube u_DiffuseEnvSampler;
+#endif
 layout (set=1, binding = ID_specularCube) uniform samplerCube u_SpecularEnvSampler;
 #define USE_TEX_LOD
 #endif
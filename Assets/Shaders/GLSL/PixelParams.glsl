@@ -77,7 +77,8 @@ struct PBRFactors
     vec4 u_BaseColorFactor;
     float u_MetallicFactor;
     float u_RoughnessFactor;
-    vec2 padding;
+    float u_LODFade;        // see discardPixelIfLODFading()
+    float padding;
 
     // KHR_materials_pbrSpecularGlossiness
     vec4 u_DiffuseFactor;
@@ -115,6 +116,16 @@ vec4 getBaseColor(VS2PS Input, PBRFactors params)
     return baseColor;
 }
 
+// ambient occlusion of the material, 1 without an occlusion texture
+float getOcclusion(VS2PS Input)
+{
+#ifdef ID_occlusionTexture
+    return texture(u_OcclusionSampler, getOcclusionUV(Input)).r;
+#else
+    return 1.0;
+#endif
+}
+
 void discardPixelIfAlphaCutOff(VS2PS Input)
 {
     vec4 baseColor = getBaseColor(Input);
@@ -130,6 +141,20 @@ void discardPixelIfAlphaCutOff(VS2PS Input)
 #endif
 }
 
+// Crossfade between two levels of detail of a mesh, both are drawn and dithered: a positive fade discards that fraction
+// of the pixels and a negative one keeps it, so the levels drawn with f and -f cover every pixel once
+void discardPixelIfLODFading(float fade)
+{
+    if (fade == 0.0)
+        return;
+
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    float dither = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+    if ((fade > 0.0) ? (dither < fade) : (dither >= -fade))
+        discard;
+}
+
 void getPBRParams(VS2PS Input, PBRFactors params, out vec3 diffuseColor, out vec3  specularColor, out float perceptualRoughness, out float alpha)
 {
     // Metallic and Roughness material properties are packed together
@@ -0,0 +1,105 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_ARB_compute_shader : enable
+
+//--------------------------------------------------------------------------------------
+// Final post processing pass: adds the last bloom upsample to the HDR target, tonemaps it
+// (tonemappingCS.glsl) and converts it to the display's encoding (ColorConversionPS.glsl),
+// all in one read and one write per pixel.
+//
+// The SDR output stays linear, the sRGB swapchain encodes it when it's copied over.
+//--------------------------------------------------------------------------------------
+
+layout (std140, binding = 0) uniform perFrame
+{
+    mat4  u_contentToMonitorRecMatrix;
+    float u_exposure;
+    int   u_toneMapper;
+    int   u_displayMode;
+    float u_displayMinLuminancePerNits;   // display min luminanace in units of 80 nits
+    float u_displayMaxLuminancePerNits;   // display max luminanace in units of 80 nits
+    float u_bloomIntensity;               // 0 when there is no bloom this frame
+} myPerFrame;
+
+layout (binding = 1) uniform sampler2D u_hdr;
+layout (binding = 2) uniform sampler2D u_bloom;
+layout (binding = 3, rgba16f) uniform writeonly image2D u_output;
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+#include "tonemappers.glsl"
+#include "bloom.h"
+
+vec3 Tonemap(vec3 color, int tonemapper)
+{
+    switch (tonemapper)
+    {
+        case 0: return AMDTonemapper(color);
+        case 1: return DX11DSK(color);
+        case 2: return Reinhard(color);
+        case 3: return Uncharted2Tonemap(color);
+        case 4: return tonemapACES( color );
+        case 5: return color;
+        default: return vec3(1, 1, 1);
+    }
+}
+
+vec3 ColorConversion(vec3 color)
+{
+    switch (myPerFrame.u_displayMode)
+    {
+        case 1:
+            // FSHDR_DisplayNative
+            color = (myPerFrame.u_contentToMonitorRecMatrix * vec4(color, 0.0)).xyz;
+            return pow(max(color, vec3(0.0)), vec3(1.0 / 2.2));
+
+        case 2:
+        case 4:
+            // FSHDR_scRGB, HDR10_scRGB
+            return color * (myPerFrame.u_displayMaxLuminancePerNits - myPerFrame.u_displayMinLuminancePerNits) + vec3(myPerFrame.u_displayMinLuminancePerNits);
+
+        case 3:
+        {
+            // HDR10_ST2084, rec2020 with the PQ curve. 1 is u_displayMaxLuminancePerNits * 80 nits and
+            // ST2084 has 1 at 10000 nits
+            color = (myPerFrame.u_contentToMonitorRecMatrix * vec4(color, 0.0)).xyz;
+            color *= myPerFrame.u_displayMaxLuminancePerNits * (80.0 / 10000.0);
+
+            float m1 = 2610.0 / 4096.0 / 4;
+            float m2 = 2523.0 / 4096.0 * 128;
+            float c1 = 3424.0 / 4096.0;
+            float c2 = 2413.0 / 4096.0 * 32;
+            float c3 = 2392.0 / 4096.0 * 32;
+            vec3 cp = pow(abs(color), vec3(m1));
+            return pow((c1 + c2 * cp) / (1 + c3 * cp), vec3(m2));
+        }
+
+        default:
+            // SDR
+            return color;
+    }
+}
+
+void main()
+{
+    ivec2 outputSize = imageSize(u_output);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, outputSize)))
+        return;
+
+    vec3 color = texelFetch(u_hdr, texel, 0).rgb * myPerFrame.u_exposure;
+
+    if (myPerFrame.u_bloomIntensity > 0.0)
+    {
+        vec2 uv = (vec2(texel) + 0.5) / vec2(outputSize);
+        vec2 bloomTexelSize = 1.0 / vec2(textureSize(u_bloom, 0));
+        color += UpsampleTent(u_bloom, uv, bloomTexelSize) * myPerFrame.u_bloomIntensity;
+    }
+
+    color = Tonemap(color, myPerFrame.u_toneMapper);
+    color = ColorConversion(color);
+
+    imageStore(u_output, texel, vec4(color, 1.0));
+}
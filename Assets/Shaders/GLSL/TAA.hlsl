@@ -17,36 +17,73 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+//--------------------------------------------------------------------------------------
+// Temporal anti-aliasing with upscaling.
+// The color, depth and velocity inputs hold the jittered frame in their top left RenderSize pixels, the history and
+// the output are OutputSize (RenderSize is never larger). Every output pixel rebuilds the current frame from the 3x3
+// input texels around it, weighted by how far from the pixel each one was sampled, and blends it with the history
+// reprojected through the velocity of the closest depth and clamped to the variance of the neighborhood.
+// That velocity is found by a pass of its own (velocity) so that the depth and the motion vectors are done with before
+// the resolve writes its output, the render graph gives it their memory.
+//--------------------------------------------------------------------------------------
+
 #define RADIUS      1
 #define GROUP_SIZE  16
-#define TILE_DIM    (2 * RADIUS + GROUP_SIZE)
+// with RenderSize <= OutputSize the input texels of a group span at most GROUP_SIZE + 1 rows and columns
+#define TILE_DIM    (2 * RADIUS + GROUP_SIZE + 1)
 
 [[vk::binding(0)]] Texture2D ColorBuffer : register(t0);
 [[vk::binding(1)]] Texture2D DepthBuffer : register(t1);
 [[vk::binding(2)]] Texture2D HistoryBuffer : register(t2);
 [[vk::binding(3)]] Texture2D VelocityBuffer : register(t3);
 
-[[vk::binding(4)]] RWTexture2D<float4> OutputBuffer : register(u4);
+[[vk::binding(4)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> OutputBuffer : register(u4);
+
+[[vk::binding(5)]] SamplerState HistorySampler : register(s0);
+
+// velocity of the closest depth around each input texel in uv, z is 1 when that depth is the sky's
+[[vk::binding(7)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> DilatedVelocity : register(u7);
 
-[[vk::binding(5)]] SamplerState ColorSampler : register(s0);
-[[vk::binding(6)]] SamplerState DepthSampler : register(s1);
-[[vk::binding(7)]] SamplerState HistorySampler : register(s2);
-[[vk::binding(8)]] SamplerState VelocitySampler : register(s3);
+// must match TAAConstants in TAA.cpp
+[[vk::binding(6)]] cbuffer TAAConstants : register(b0)
+{
+    float2 RenderSize;
+    float2 OutputSize;
+    float2 Jitter;      // input texel t was shaded at t + 0.5 + Jitter of the unjittered frame, in input pixels
+    float2 Padding;
+};
 
 groupshared float3 Tile[TILE_DIM * TILE_DIM];
 
-float2 GetClosestVelocity(in float2 uv, in float2 texelSize, out bool isSkyPixel)
+// Position of the center of an output pixel in the input, in input pixels
+float2 GetInputPosition(in float2 outputPixel)
+{
+    return (outputPixel + 0.5f) * RenderSize / OutputSize;
+}
+
+// Input texel whose sample landed the closest to an input position
+int2 GetInputTexel(in float2 inputPos)
+{
+    return int2(floor(inputPos - Jitter));
+}
+
+int2 ClampToRender(in int2 texel)
+{
+    return clamp(texel, int2(0, 0), int2(RenderSize) - 1);
+}
+
+float2 GetClosestVelocity(in int2 texel, out bool isSkyPixel)
 {
-    float2 velocity;
+    float2 velocity = float2(0.0f, 0.0f);
     float closestDepth = 9.9f;
     for (int y = -1; y <= 1; ++y)
         for (int x = -1; x <= 1; ++x)
         {
-            const float2 st = uv + float2(x, y) * texelSize;
-            const float depth = DepthBuffer.SampleLevel(DepthSampler, st, 0.0f).x;
+            const int3 st = int3(ClampToRender(texel + int2(x, y)), 0);
+            const float depth = DepthBuffer.Load(st).x;
             if (depth < closestDepth)
             {
-                velocity = VelocityBuffer.SampleLevel(VelocitySampler, st, 0.0f).xy;
+                velocity = VelocityBuffer.Load(st).xy;
                 closestDepth = depth;
             }
         }
@@ -136,127 +173,126 @@ float3 Reinhard(in float3 hdr)
     return hdr / (hdr + 1.0f);
 }
 
-float3 Tap(in float2 pos)
+float3 Tap(in int2 pos)
 {
-    return Tile[int(pos.x) + TILE_DIM * int(pos.y)];
+    return Tile[pos.x + TILE_DIM * pos.y];
 }
 
-[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
-void main(uint3 globalID : SV_DispatchThreadID, uint3 localID : SV_GroupThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
+// Loads the tonemapped input texels of the group, anchor is the top left one
+void LoadTile(in uint localIndex, in int2 anchor)
 {
-    int3 dims;
-    bool isSkyPixel;
-
-    // Populate private memory
-    ColorBuffer.GetDimensions(0, dims.x, dims.y, dims.z);
-    const float2 texelSize = 1.0f / float2(dims.xy);
-    const float2 uv = (globalID.xy + 0.5f) * texelSize;
-    const float2 tilePos = localID.xy + RADIUS + 0.5f;
-
-    // Populate local memory
-    if (localIndex < TILE_DIM * TILE_DIM / 4)
+    for (uint i = localIndex; i < TILE_DIM * TILE_DIM; i += GROUP_SIZE * GROUP_SIZE)
     {
-        const int2 anchor = groupID.xy * GROUP_SIZE - RADIUS;
-
-        const int2 coord1 = anchor + int2(localIndex % TILE_DIM, localIndex / TILE_DIM);
-        const int2 coord2 = anchor + int2((localIndex + TILE_DIM * TILE_DIM / 4) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM / 4) / TILE_DIM);
-        const int2 coord3 = anchor + int2((localIndex + TILE_DIM * TILE_DIM / 2) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM / 2) / TILE_DIM);
-        const int2 coord4 = anchor + int2((localIndex + TILE_DIM * TILE_DIM * 3 / 4) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM * 3 / 4) / TILE_DIM);
-
-        const float2 uv1 = (coord1 + 0.5f) * texelSize;
-        const float2 uv2 = (coord2 + 0.5f) * texelSize;
-        const float2 uv3 = (coord3 + 0.5f) * texelSize;
-        const float2 uv4 = (coord4 + 0.5f) * texelSize;
-
-        const float3 color0 = ColorBuffer.SampleLevel(ColorSampler, uv1, 0.0f).xyz;
-        const float3 color1 = ColorBuffer.SampleLevel(ColorSampler, uv2, 0.0f).xyz;
-        const float3 color2 = ColorBuffer.SampleLevel(ColorSampler, uv3, 0.0f).xyz;
-        const float3 color3 = ColorBuffer.SampleLevel(ColorSampler, uv4, 0.0f).xyz;
-
-        Tile[localIndex]                               = Reinhard(color0);
-        Tile[localIndex + TILE_DIM * TILE_DIM / 4]     = Reinhard(color1);
-        Tile[localIndex + TILE_DIM * TILE_DIM / 2]     = Reinhard(color2);
-        Tile[localIndex + TILE_DIM * TILE_DIM * 3 / 4] = Reinhard(color3);
+        const int2 coord = ClampToRender(anchor + int2(i % TILE_DIM, i / TILE_DIM));
+        Tile[i] = Reinhard(ColorBuffer.Load(int3(coord, 0)).xyz);
     }
     GroupMemoryBarrierWithGroupSync();
+}
 
-    // Iterate the neighboring samples
-    if (any(int2(globalID.xy) >= dims.xy))
-        return; // out of bounds
+struct Neighborhood
+{
+    float3 current;     // this frame at the output pixel
+    float  confidence;  // 1 when a sample landed right on the output pixel
+    float3 mean;
+    float3 deviation;
+};
+
+Neighborhood GatherNeighborhood(in int2 tilePos, in int2 texel, in float2 inputPos)
+{
+    Neighborhood n;
+    n.current = float3(0.0f, 0.0f, 0.0f);
+    n.confidence = 0.0f;
 
     float wsum = 0.0f;
+    float csum = 0.0f;
     float3 vsum = float3(0.0f, 0.0f, 0.0f);
     float3 vsum2 = float3(0.0f, 0.0f, 0.0f);
 
-    for (float y = -RADIUS; y <= RADIUS; ++y)
-        for (float x = -RADIUS; x <= RADIUS; ++x)
+    for (int y = -RADIUS; y <= RADIUS; ++y)
+        for (int x = -RADIUS; x <= RADIUS; ++x)
         {
-            const float3 neigh = Tap(tilePos + float2(x, y));
+            const float3 neigh = Tap(tilePos + int2(x, y));
             const float w = exp(-3.0f * (x * x + y * y) / ((RADIUS + 1.0f) * (RADIUS + 1.0f)));
             vsum2 += neigh * neigh * w;
             vsum += neigh * w;
             wsum += w;
+
+            // Gaussian fit of Blackman-Harris on the distance between the output pixel and where the texel was sampled
+            const float2 d = float2(texel + int2(x, y)) + 0.5f + Jitter - inputPos;
+            const float c = exp(-2.29f * dot(d, d));
+            n.current += neigh * c;
+            n.confidence = max(n.confidence, c);
+            csum += c;
         }
 
     // Calculate mean and standard deviation
-    const float3 ex = vsum / wsum;
-    const float3 ex2 = vsum2 / wsum;
-    const float3 dev = sqrt(max(ex2 - ex * ex, 0.0f));
+    n.current /= csum;
+    n.mean = vsum / wsum;
+    n.deviation = sqrt(max(vsum2 / wsum - n.mean * n.mean, 0.0f));
+    return n;
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void velocity(uint3 globalID : SV_DispatchThreadID)
+{
+    if (any(globalID.xy >= uint2(RenderSize)))
+        return; // out of bounds
 
-    const float2 velocity = GetClosestVelocity(uv, texelSize, isSkyPixel);
+    bool isSkyPixel;
+    const float2 closest = GetClosestVelocity(int2(globalID.xy), isSkyPixel);
+    DilatedVelocity[globalID.xy] = float4(closest, isSkyPixel ? 1.0f : 0.0f, 0.0f);
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void main(uint3 globalID : SV_DispatchThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
+{
+    // the input texels of the group start at the ones of its first output pixel
+    const int2 anchor = GetInputTexel(GetInputPosition(groupID.xy * GROUP_SIZE)) - RADIUS;
+    LoadTile(localIndex, anchor);
+
+    if (any(globalID.xy >= uint2(OutputSize)))
+        return; // out of bounds
+
+    const float2 inputPos = GetInputPosition(globalID.xy);
+    const int2 texel = GetInputTexel(inputPos);
+    const Neighborhood n = GatherNeighborhood(texel - anchor, texel, inputPos);
+
+    const float4 dilated = DilatedVelocity[ClampToRender(texel)];
+    const float2 velocity = dilated.xy;
+    const bool isSkyPixel = dilated.z > 0.5f;
     const float boxSize = lerp(0.5f, 2.5f, isSkyPixel ? 0.0f : smoothstep(0.02f, 0.0f, length(velocity)));
 
     // Reproject and clamp to bounding box
-    const float3 nmin = ex - dev * boxSize;
-    const float3 nmax = ex + dev * boxSize;
+    const float3 nmin = n.mean - n.deviation * boxSize;
+    const float3 nmax = n.mean + n.deviation * boxSize;
 
-    const float3 history = SampleHistoryCatmullRom(uv - velocity, texelSize);
+    const float2 uv = (globalID.xy + 0.5f) / OutputSize;
+    const float2 historyUV = uv - velocity;
+    const float3 history = SampleHistoryCatmullRom(historyUV, 1.0f / OutputSize);
     const float3 clampedHistory = clamp(history, nmin, nmax);
-    const float3 center = Tap(tilePos); // retrieve center value
-    const float3 result = lerp(clampedHistory, center, 1.0f / 16.0f);
+
+    // trust the samples that landed close to the pixel more, drop the history that comes from off screen
+    float blend = lerp(1.0f / 48.0f, 1.0f / 12.0f, n.confidence);
+    if (any(historyUV < 0.0f) || any(historyUV > 1.0f))
+        blend = 1.0f;
+    const float3 result = lerp(clampedHistory, n.current, blend);
 
     // Write antialised sample to memory
     OutputBuffer[globalID.xy] = float4(result, 1.0f);
 }
 
+// No valid history, only upscales the current frame
 [numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
-void first(uint3 globalID : SV_DispatchThreadID, uint3 localID : SV_GroupThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
+void first(uint3 globalID : SV_DispatchThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
 {
-    int3 dims;
-    bool isSkyPixel;
+    const int2 anchor = GetInputTexel(GetInputPosition(groupID.xy * GROUP_SIZE)) - RADIUS;
+    LoadTile(localIndex, anchor);
 
-    // Populate private memory
-    ColorBuffer.GetDimensions(0, dims.x, dims.y, dims.z);
-    const float2 texelSize = 1.0f / float2(dims.xy);
-    const float2 uv = (globalID.xy + 0.5f) * texelSize;
-    const float2 tilePos = localID.xy + RADIUS + 0.5f;
+    if (any(globalID.xy >= uint2(OutputSize)))
+        return; // out of bounds
 
-    // Populate local memory
-    if (localIndex < TILE_DIM * TILE_DIM / 4)
-    {
-        const int2 anchor = groupID.xy * GROUP_SIZE - RADIUS;
-
-        const int2 coord1 = anchor + int2(localIndex % TILE_DIM, localIndex / TILE_DIM);
-        const int2 coord2 = anchor + int2((localIndex + TILE_DIM * TILE_DIM / 4) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM / 4) / TILE_DIM);
-        const int2 coord3 = anchor + int2((localIndex + TILE_DIM * TILE_DIM / 2) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM / 2) / TILE_DIM);
-        const int2 coord4 = anchor + int2((localIndex + TILE_DIM * TILE_DIM * 3 / 4) % TILE_DIM, (localIndex + TILE_DIM * TILE_DIM * 3 / 4) / TILE_DIM);
-
-        const float2 uv1 = (coord1 + 0.5f) * texelSize;
-        const float2 uv2 = (coord2 + 0.5f) * texelSize;
-        const float2 uv3 = (coord3 + 0.5f) * texelSize;
-        const float2 uv4 = (coord4 + 0.5f) * texelSize;
-
-        const float3 color0 = ColorBuffer.SampleLevel(ColorSampler, uv1, 0.0f).xyz;
-        const float3 color1 = ColorBuffer.SampleLevel(ColorSampler, uv2, 0.0f).xyz;
-        const float3 color2 = ColorBuffer.SampleLevel(ColorSampler, uv3, 0.0f).xyz;
-        const float3 color3 = ColorBuffer.SampleLevel(ColorSampler, uv4, 0.0f).xyz;
-
-        Tile[localIndex] = Reinhard(color0);
-        Tile[localIndex + TILE_DIM * TILE_DIM / 4] = Reinhard(color1);
-        Tile[localIndex + TILE_DIM * TILE_DIM / 2] = Reinhard(color2);
-        Tile[localIndex + TILE_DIM * TILE_DIM * 3 / 4] = Reinhard(color3);
-    }
-    GroupMemoryBarrierWithGroupSync();
-    const float3 center = Tap(tilePos);
-    OutputBuffer[globalID.xy] = float4(center, 1.0);
+    const float2 inputPos = GetInputPosition(globalID.xy);
+    const int2 texel = GetInputTexel(inputPos);
+    const Neighborhood n = GatherNeighborhood(texel - anchor, texel, inputPos);
+    OutputBuffer[globalID.xy] = float4(n.current, 1.0f);
 }
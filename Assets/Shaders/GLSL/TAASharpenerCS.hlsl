@@ -21,8 +21,13 @@
 // Texture definitions
 //--------------------------------------------------------------------------------------
 [[vk::binding(0)]] Texture2D<float4> TAABuffer : register(t0);
-[[vk::binding(1)]] RWTexture2D<float4> HDR : register(u0);
-[[vk::binding(2)]] RWTexture2D<float4> History : register(u1);
+// the storage images are declared with their formats, the HDR target is R11G11B10 with the compact GBuffer
+#if HDR_R11G11B10
+[[vk::binding(1)]] [[vk::image_format("r11g11b10f")]] RWTexture2D<float4> HDR : register(u0);
+#else
+[[vk::binding(1)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> HDR : register(u0);
+#endif
+[[vk::binding(2)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> History : register(u1);
 
 //--------------------------------------------------------------------------------------
 // Helper functions
@@ -67,6 +72,11 @@ float3 ReinhardInverse(in float3 sdr)
 [numthreads(8, 8, 1)]
 void mainCS(uint3 globalID : SV_DispatchThreadID, uint3 localID : SV_GroupThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
 {
+    uint2 dims;
+    History.GetDimensions(dims.x, dims.y);
+    if (any(globalID.xy >= dims))
+        return; // out of bounds
+
     const float3 center = TAABuffer[globalID.xy].xyz;
     const float3 top    = TAABuffer[globalID.xy + uint2( 0,  1)].xyz;
     const float3 left   = TAABuffer[globalID.xy + uint2( 1,  0)].xyz;
@@ -82,6 +92,11 @@ void mainCS(uint3 globalID : SV_DispatchThreadID, uint3 localID : SV_GroupThread
 [numthreads(8, 8, 1)]
 void postCS(uint3 globalID : SV_DispatchThreadID, uint3 localID : SV_GroupThreadID, uint localIndex : SV_GroupIndex, uint3 groupID : SV_GroupID)
 {
+    uint2 dims;
+    History.GetDimensions(dims.x, dims.y);
+    if (any(globalID.xy >= dims))
+        return; // out of bounds
+
     const float3 center = TAABuffer[globalID.xy].xyz;
 
     HDR[globalID.xy] = float4(ReinhardInverse(center), 1.0f);
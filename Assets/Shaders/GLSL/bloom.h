@@ -0,0 +1,25 @@
+//--------------------------------------------------------------------------------------
+// Shared by Bloom-comp.glsl and PostProcess-comp.glsl
+//--------------------------------------------------------------------------------------
+
+// 3x3 tent around uv, used to bring a bloom mip up one level. The taps are bilinear so it
+// smooths over 4x4 source texels.
+vec3 UpsampleTent(sampler2D source, vec2 uv, vec2 texelSize)
+{
+    vec4 d = texelSize.xyxy * vec4(1.0, 1.0, -1.0, 0.0);
+
+    vec3 s;
+    s  = texture(source, uv - d.xy).rgb;
+    s += texture(source, uv - d.wy).rgb * 2.0;
+    s += texture(source, uv - d.zy).rgb;
+
+    s += texture(source, uv + d.zw).rgb * 2.0;
+    s += texture(source, uv       ).rgb * 4.0;
+    s += texture(source, uv + d.xw).rgb * 2.0;
+
+    s += texture(source, uv + d.zy).rgb;
+    s += texture(source, uv + d.wy).rgb * 2.0;
+    s += texture(source, uv + d.xy).rgb;
+
+    return s * (1.0 / 16.0);
+}
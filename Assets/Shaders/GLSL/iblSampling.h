@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Shared by IBLIrradianceSH-comp.glsl and IBLPrefilter-comp.glsl
+//--------------------------------------------------------------------------------------
+
+const float IBL_PI = 3.141592653589793;
+
+// must match IBLConstants in SkyDome.cpp
+layout (std140, binding = 0) uniform iblConstants
+{
+    float u_roughness;      // perceptual roughness of the mip being prefiltered
+    float u_sourceLod;      // mip of the environment read by the projection
+    float u_sourceSize;     // width of mip 0 of the environment
+    uint  u_faceSize;       // width of the faces written
+    uint  u_sampleCount;
+    uint  u_partialCount;   // groups of the projection, read by the resolve
+} myIBL;
+
+// Direction through a face at st in [-1, 1], not normalized. The faces are in the Vulkan order, +X, -X, +Y, -Y, +Z, -Z,
+// must match GetCubeMapDirection() in SphericalHarmonics.cpp
+vec3 cubeMapDirection(uint face, vec2 st)
+{
+    switch (face)
+    {
+        case 0:  return vec3( 1.0, -st.y, -st.x);
+        case 1:  return vec3(-1.0, -st.y,  st.x);
+        case 2:  return vec3( st.x,  1.0,  st.y);
+        case 3:  return vec3( st.x, -1.0, -st.y);
+        case 4:  return vec3( st.x, -st.y,  1.0);
+        default: return vec3(-st.x, -st.y, -1.0);
+    }
+}
+
+// texel center of a face of faceSize texels, in [-1, 1]
+vec2 cubeMapFaceCoords(uvec2 texel, uint faceSize)
+{
+    return (vec2(texel) + 0.5) * (2.0 / float(faceSize)) - 1.0;
+}
+
+vec2 hammersley(uint i, uint count)
+{
+    return vec2(float(i) / float(count), float(bitfieldReverse(i)) * 2.3283064365386963e-10);
+}
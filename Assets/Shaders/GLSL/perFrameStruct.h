@@ -20,8 +20,14 @@
 // KHR_lights_punctual extension.
 // see https://github.com/KhronosGroup/glTF/tree/master/extensions/2.0/Khronos/KHR_lights_punctual
 
-#define MAX_LIGHT_INSTANCES  80
-#define MAX_SHADOW_INSTANCES 32
+// Clustered lighting, must match GLTFLightClusters.h
+#define LIGHT_CLUSTER_COUNT_X 16
+#define LIGHT_CLUSTER_COUNT_Y 9
+#define LIGHT_CLUSTER_COUNT_Z 24
+#define LIGHT_CLUSTER_STRIDE  256
+
+// Cascaded shadows, must match MaxShadowCascades in GLTFCommon.h
+#define MAX_SHADOW_CASCADES 4
 
 struct Light
 {
@@ -41,6 +47,11 @@ struct Light
     int           type;
     float         depthBias;
     int           shadowMapIndex;
+
+    vec4          shadowAtlasRect;  // scale.xy and offset.xy of the light's tile in the shadow atlas
+
+    uint          shadowCascades;   // the shadow is in the cascades of PerFrame, 0 for a single shadow map
+    uvec3         padding;
 };
 
 const int LightType_Directional = 0;
@@ -62,5 +73,18 @@ struct PerFrame
     float         u_LodBias;
     vec2          u_padding;
     int           u_lightCount;
-    Light         u_lights[MAX_LIGHT_INSTANCES];
+
+    mat4          u_mCameraView;
+    vec2          u_clusterProjScale;
+    float         u_clusterDepthScale;
+    float         u_clusterDepthBias;
+
+    mat4          u_cascadeViewProj[MAX_SHADOW_CASCADES];
+    vec4          u_cascadeAtlasRect[MAX_SHADOW_CASCADES];
+    float         u_cascadeSplits[MAX_SHADOW_CASCADES];    // view space depth where each cascade ends
+    float         u_cascadeBlend;
+    uvec3         u_cascadePadding;
+
+    // diffuse irradiance of the IBL, see SphericalHarmonics.h
+    vec4          u_irradianceSH[9];
 };
@@ -18,19 +18,25 @@
 // THE SOFTWARE.
 
 #ifdef ID_shadowMap
-layout(set = 1, binding = ID_shadowMap) uniform sampler2DShadow u_shadowMap[MAX_SHADOW_INSTANCES];
+// all the shadows live in tiles of one atlas, see GLTFShadowAtlasVK.h
+layout(set = 1, binding = ID_shadowMap) uniform sampler2DShadow u_shadowMap;
 #endif
 
-// shadowmap filtering
-float FilterShadow(int shadowIndex, vec3 uv)
+// shadowmap filtering, uv is in the tile at atlasRect
+float FilterShadow(vec4 atlasRect, vec3 uv)
 {
     float shadow = 0.0;
 #ifdef ID_shadowMap
-    ivec2 texDim = textureSize(u_shadowMap[shadowIndex], 0);
+    vec2 atlasSize = vec2(textureSize(u_shadowMap, 0));
+    vec2 texelSize = 1.0 / atlasSize;
     float scale = 1.0;
-    float dx = scale * 1.0 / float(texDim.x);
-    float dy = scale * 1.0 / float(texDim.y);
+    float dx = scale * texelSize.x;
+    float dy = scale * texelSize.y;
 
+    // keep the kernel inside the tile, the neighbours belong to other lights
+    vec2 tileMin = atlasRect.zw + 0.5 * texelSize;
+    vec2 tileMax = atlasRect.zw + atlasRect.xy - 0.5 * texelSize;
+    vec2 atlasUV = uv.xy * atlasRect.xy + atlasRect.zw;
 
     int kernelLevel = 2;
     int kernelWidth = 2 * kernelLevel + 1;
@@ -38,7 +44,8 @@ float FilterShadow(int shadowIndex, vec3 uv)
     {
         for (int j = -kernelLevel; j <= kernelLevel; j++)
         {
-            shadow += texture(u_shadowMap[shadowIndex], uv + vec3(dx*i, dy*j, 0)).r;
+            vec2 sampleUV = clamp(atlasUV + vec2(dx*i, dy*j), tileMin, tileMax);
+            shadow += texture(u_shadowMap, vec3(sampleUV, uv.z)).r;
         }
     }
 
@@ -47,6 +54,59 @@ float FilterShadow(int shadowIndex, vec3 uv)
     return shadow;
 }
 
+#ifdef ID_shadowMap
+float SampleCascade(vec3 vPosition, Light light, int cascade, out bool bInside)
+{
+    vec4 shadowTexCoord = myPerFrame.u_cascadeViewProj[cascade] * vec4(vPosition, 1.0);
+    shadowTexCoord.xyz = shadowTexCoord.xyz / shadowTexCoord.w;
+    shadowTexCoord.x = (1.0 + shadowTexCoord.x) * 0.5;
+    shadowTexCoord.y = (1.0 - shadowTexCoord.y) * 0.5;
+
+    bInside = all(greaterThanEqual(shadowTexCoord.xyz, vec3(0.0))) && all(lessThanEqual(shadowTexCoord.xyz, vec3(1.0)));
+    if (!bInside)
+        return 1.0;
+
+    shadowTexCoord.z -= light.depthBias;
+    return FilterShadow(myPerFrame.u_cascadeAtlasRect[cascade], shadowTexCoord.xyz);
+}
+
+//
+// Picks the cascade from the view depth and cross-fades it into the next one near its end
+//
+float DoCascadedShadow(vec3 vPosition, Light light)
+{
+    float depth = -(myPerFrame.u_mCameraView * vec4(vPosition, 1.0)).z;
+    int cascadeCount = int(light.shadowCascades);
+
+    for (int c = 0; c < cascadeCount; c++)
+    {
+        if (depth > myPerFrame.u_cascadeSplits[c])
+            continue;
+
+        // a cascade whose refresh is late can miss the point, the next one is bigger
+        bool bInside;
+        float shadow = SampleCascade(vPosition, light, c, bInside);
+        if (!bInside)
+            continue;
+
+        float splitNear = c > 0 ? myPerFrame.u_cascadeSplits[c - 1] : 0.0;
+        float blendRange = (myPerFrame.u_cascadeSplits[c] - splitNear) * myPerFrame.u_cascadeBlend;
+        float fade = blendRange > 0.0 ? (myPerFrame.u_cascadeSplits[c] - depth) / blendRange : 1.0;
+        if (c + 1 < cascadeCount && fade < 1.0)
+        {
+            bool bNextInside;
+            float nextShadow = SampleCascade(vPosition, light, c + 1, bNextInside);
+            if (bNextInside)
+                shadow = mix(nextShadow, shadow, fade);
+        }
+        return shadow;
+    }
+
+    // past the last cascade
+    return 1.0;
+}
+#endif
+
 //
 // Project world space point onto shadowmap
 //
@@ -56,6 +116,9 @@ float DoSpotShadow(vec3 vPosition, Light light)
     if (light.shadowMapIndex < 0)
         return 1.0f;
 
+    if (light.shadowCascades > 0)
+        return DoCascadedShadow(vPosition, light);
+
     if (light.type != LightType_Spot && light.type != LightType_Directional)
         return 1.0; // no other light types cast shadows for now
 
@@ -82,15 +145,9 @@ float DoSpotShadow(vec3 vPosition, Light light)
         if (shadowTexCoord.z > 1.0f) return 1.0f;
     }
 
-    // offsets of the center of the shadow map atlas
-    /*float offsetsX[4] = { 0.0, 1.0, 0.0, 1.0 };
-    float offsetsY[4] = { 0.0, 0.0, 1.0, 1.0 };
-    shadowTexCoord.x += offsetsX[light.shadowMapIndex] * .5;
-    shadowTexCoord.y += offsetsY[light.shadowMapIndex] * .5;*/
-
     shadowTexCoord.z -= light.depthBias;
 
-    return FilterShadow(light.shadowMapIndex, shadowTexCoord.xyz);
+    return FilterShadow(light.shadowAtlasRect, shadowTexCoord.xyz);
 #else
     return 1.0f;
 #endif